@@ -0,0 +1,79 @@
+// Sampler benchmark: feeds synthetic accelerometer batches through the app's
+// subscribed handler and reports the cost per sample.  Built once per build
+// variant by the Makefile; `make bench` prints the table.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES 1
+#endif
+
+#define main rc_app_main
+#include "../src/main.c"
+#undef main
+#include "stub.h"
+
+static long bench_batches = 250000;
+static uint64_t bench_ticks = 0; // cycles (x86) or ns spent in the sampler
+static uint64_t bench_ns = 0;
+
+static uint64_t bench_clock_ns(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t bench_ticks_now(){
+#ifdef BENCH_CYCLES
+  return __rdtsc();
+#else
+  return bench_clock_ns();
+#endif
+}
+
+// The wrist rocks slowly on both axes with some noise, so the tilt crosses the
+// thresholds and the cursor and overlay keep changing.
+static void bench_fill(AccelData* data, long batch){
+  for(int i = 0; i < ACCEL_SAMPLES_PER_BATCH; i++){
+    double t = (batch * ACCEL_SAMPLES_PER_BATCH + i) * ACCEL_SAMPLE_PERIOD_MS / 1000.0;
+    data[i].x = 250 * sin(t * 1.3) + (rand() % 31) - 15;
+    data[i].y = 200 * sin(t * 0.7 + 1) + (rand() % 31) - 15;
+    data[i].z = -1000 + 100 * cos(t * 0.9) + (rand() % 31) - 15;
+    data[i].did_vibrate = false;
+    data[i].timestamp = stub_now_ms() + i * ACCEL_SAMPLE_PERIOD_MS;
+  }
+}
+
+static void bench_run(){
+  AccelData data[ACCEL_SAMPLES_PER_BATCH];
+  srand(1);
+  uint64_t ns0 = bench_clock_ns();
+  for(long b = 0; b < bench_batches; b++){
+    bench_fill(data, b);
+    uint64_t t0 = bench_ticks_now();
+    if(!stub_accel(data, ACCEL_SAMPLES_PER_BATCH)){
+      fprintf(stderr, "bench: sampler is not subscribed\n");
+      exit(1);
+    }
+    bench_ticks += bench_ticks_now() - t0;
+    stub_advance(ACCEL_SAMPLES_PER_BATCH * ACCEL_SAMPLE_PERIOD_MS); // lets the frame timer flush
+  }
+  bench_ns = bench_clock_ns() - ns0;
+}
+
+int main(int argc, char** argv){
+  if(argc > 1) bench_batches = atol(argv[1]);
+  stub_event_loop = bench_run;
+  rc_app_main();
+  double samples = (double)bench_batches * ACCEL_SAMPLES_PER_BATCH;
+#ifdef BENCH_CYCLES
+  printf("%8.1f cycles/sample in sampler", bench_ticks / samples);
+#else
+  printf("%8.1f ns/sample in sampler", bench_ticks / samples);
+#endif
+  printf(", %6.1f ns/sample with frames (%d frames, %d coalesced)\n", bench_ns / samples, frame_count, frame_coalesced);
+  return 0;
+}
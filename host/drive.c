@@ -0,0 +1,350 @@
+// Keystroke driver: presses calculator keys through the app's select handler,
+// exactly as a wrist would (cursor on a button, then SELECT), and checks every
+// display against the reference model in reference.c.
+//
+//   drive [-n sequences] [-j jobs] [-s seed] [-l maxlen] [-f script] [-r repeats] [--walk] [-v]
+//
+// Without -f it plays random key sequences; with -f it plays the lines of a
+// script (keys 0-9 . + - * / = C and < for backspace, '#' starts a comment).
+// Sequences are shared out over -j forked workers, default one per core.
+// --walk steps the cursor to each key with tilts instead of placing it, and
+// reports the steps per keystroke; use -j 1 so the predictor sees every press.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define main rc_app_main
+#include "../src/main.c"
+#undef main
+#include "stub.h"
+#include "reference.h"
+
+#define DRIVE_MAX_KEYS 256
+#define DRIVE_MAX_SCRIPT 4096
+#define DRIVE_REPORTS 3 // repro lines printed per worker
+#define DRIVE_KEY_MS 50 // time between presses
+
+_Static_assert(REF_DISPLAY_SIZE == GLOBAL_BUFFER_SIZE, "reference display size");
+
+typedef struct{
+  long sequences;
+  long keys;
+  long mismatches;
+  long uncertain; // sequences cut short where the model can't predict the float result
+  long resyncs;
+  long pauses;    // presses made with the sampler suspended
+  long steps;     // cursor steps in --walk mode
+  long walked;    // keys reached by walking, excluding the first of each sequence
+  long handler_ns;
+} drive_result;
+
+static long drive_n = 20000;
+static int drive_jobs = 0;
+static uint64_t drive_seed = 1;
+static int drive_maxlen = 24;
+static const char* drive_script = NULL;
+static int drive_repeats = 1;
+static bool drive_walk = false;
+static bool drive_verbose = false;
+
+static char* script_lines[DRIVE_MAX_SCRIPT];
+static int script_count = 0;
+
+static char labels[ARRAY_SIZE_BUTTONS][GLOBAL_BUFFER_SIZE]; // to catch writes past the display buffer
+static drive_result result;
+
+static uint64_t drive_clock_ns(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t splitmix(uint64_t* s){
+  uint64_t z = (*s += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static char key_of(rc_button* button){
+  const char* label = _buffers[button->bufid];
+  return strcmp(label, "<-") == 0 ? '<' : label[0];
+}
+
+static rc_button* button_of(char key){
+  for(int i = 0; i < calc->buttonset->count; i++){
+    if(key_of(calc->buttonset->buttons[i]) == key) return calc->buttonset->buttons[i];
+  }
+  return NULL;
+}
+
+/**
+ * A random sequence, mostly digits, with the odd long run to fill the display.
+ */
+static int random_keys(uint64_t* s, char* keys){
+  static const char ops[] = "+-*/";
+  int len = 1 + splitmix(s) % drive_maxlen;
+  int n = 0;
+  while(n < len){
+    int r = splitmix(s) % 100;
+    if(r < 3){
+      for(int run = 10 + splitmix(s) % 12; run > 0 && n < DRIVE_MAX_KEYS - 1; run--) keys[n++] = '0' + splitmix(s) % 10;
+      continue;
+    }
+    if(r < 55) keys[n] = '0' + splitmix(s) % 10;
+    else if(r < 61) keys[n] = '.';
+    else if(r < 79) keys[n] = ops[splitmix(s) % 4];
+    else if(r < 91) keys[n] = '=';
+    else if(r < 94) keys[n] = 'C';
+    else keys[n] = '<';
+    n++;
+  }
+  keys[n] = 0;
+  return n;
+}
+
+/**
+ * Put the app back to the state it starts in, keeping what it has learned.
+ */
+static void reset_app(){
+  calc->mode = CALC_MODE_NEWOP;
+  calc->tmpval = 0;
+  calc->tmpop = 0;
+  strcpy(_buffers[calc->bufid_op], CALC_OP_INITIAL);
+  strcpy(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
+  calc->cursor.x = POSITION_BUTTONS_X;
+  calc->cursor.y = POSITION_BUTTONS_Y;
+  predict_prev = -1;
+}
+
+/**
+ * Tilt the cursor onto the button one step at a time; returns the steps taken.
+ */
+static int walk_to(rc_button* button){
+  int steps = 0;
+  while(calc->cursor.x != button->left || calc->cursor.y != button->top){
+    int dx = (button->left > calc->cursor.x) - (button->left < calc->cursor.x);
+    int dy = (button->top > calc->cursor.y) - (button->top < calc->cursor.y);
+    tilt = (dy < 0 ? 7 : dy > 0 ? 1 : 4) + dx + 1; // see update_cursor
+    update_cursor();
+    if(++steps > 100){
+      fprintf(stderr, "drive: cursor can't reach '%c'\n", key_of(button));
+      exit(2);
+    }
+  }
+  tilt = 5;
+  return steps;
+}
+
+static void report(const char* keys, int at, const char* why){
+  if(result.mismatches > DRIVE_REPORTS) return;
+  fprintf(stderr, "mismatch: %.*s[%c]%s: %s\n", at, keys, keys[at], keys + at + 1, why);
+}
+
+/**
+ * Play one sequence, checking the app after every key.
+ */
+static void play(const char* keys){
+  ref_calc ref;
+  char why[160];
+  uint64_t pause = result.keys; // when to stop and think
+  ref_reset(&ref);
+  reset_app();
+  result.sequences++;
+  for(int i = 0; keys[i]; i++){
+    rc_button* button = button_of(keys[i]);
+    if(button == NULL) continue; // spaces and the like in scripts
+    if(drive_walk){
+      int steps = walk_to(button);
+      if(i > 0){
+        result.steps += steps;
+        result.walked++;
+      }
+    } else {
+      calc->cursor.x = button->left;
+      calc->cursor.y = button->top;
+    }
+    if(drive_script == NULL && splitmix(&pause) % 50 == 0){ // long enough for the sampler to suspend
+      stub_advance(IDLE_TIMEOUT_MS + 1000);
+      if(!sampler_active) result.pauses++;
+    }
+    uint64_t t0 = drive_clock_ns();
+    stub_click(BUTTON_ID_SELECT);
+    result.handler_ns += drive_clock_ns() - t0;
+    stub_advance(DRIVE_KEY_MS);
+    result.keys++;
+
+    const char* display = text_layer_get_text(_textlayers[calc->tlid_num]);
+    const char* op = text_layer_get_text(_textlayers[calc->tlid_op]);
+    bool ok = true;
+    if(!sampler_active){
+      snprintf(why, sizeof(why), "the press didn't resume the sampler");
+      ok = false;
+    }
+    for(int b = 0; ok && b < calc->buttonset->count; b++){
+      if(strcmp(_buffers[calc->buttonset->buttons[b]->bufid], labels[b]) != 0){
+        snprintf(why, sizeof(why), "label of button %d overwritten", b);
+        ok = false;
+      }
+    }
+    if(ok && (strnlen(display, GLOBAL_BUFFER_SIZE) == GLOBAL_BUFFER_SIZE || strnlen(op, GLOBAL_BUFFER_SIZE) == GLOBAL_BUFFER_SIZE)){
+      snprintf(why, sizeof(why), "display not terminated within its buffer");
+      ok = false;
+    }
+    ref_status status = ref_press(&ref, keys[i]);
+    if(status == REF_UNCERTAIN){
+      result.uncertain++;
+      return;
+    }
+    if(status == REF_RESYNC){
+      ref_resync(&ref, display);
+      result.resyncs++;
+    }
+    if(ok) ok = ref_check(&ref, display, op, why, sizeof(why));
+    if(!ok){
+      result.mismatches++;
+      report(keys, i, why);
+      return;
+    }
+    if(ref.computed && !ref.e) ref_resync(&ref, display); // go on from the checked result as shown
+    if(drive_verbose) fprintf(stderr, "%c -> %s %s\n", keys[i], op, display);
+  }
+}
+
+static void run_share(int job, int jobs){
+  char keys[DRIVE_MAX_KEYS];
+  memset(&result, 0, sizeof(result));
+  for(int r = 0; r < drive_repeats; r++){
+    if(drive_script != NULL){
+      for(int i = job; i < script_count; i += jobs) play(script_lines[i]);
+    } else {
+      for(long i = job; i < drive_n; i += jobs){
+        uint64_t s = drive_seed ^ ((uint64_t)i * 0xd1b54a32d192ed03ULL);
+        random_keys(&s, keys);
+        play(keys);
+      }
+    }
+  }
+}
+
+static void add(drive_result* a, const drive_result* b){
+  a->sequences += b->sequences;
+  a->keys += b->keys;
+  a->mismatches += b->mismatches;
+  a->uncertain += b->uncertain;
+  a->resyncs += b->resyncs;
+  a->pauses += b->pauses;
+  a->steps += b->steps;
+  a->walked += b->walked;
+  a->handler_ns += b->handler_ns;
+}
+
+static void drive(){
+  drive_result total;
+  memset(&total, 0, sizeof(total));
+  for(int b = 0; b < calc->buttonset->count; b++) strcpy(labels[b], _buffers[calc->buttonset->buttons[b]->bufid]);
+  uint64_t t0 = drive_clock_ns();
+  if(drive_jobs == 1){
+    run_share(0, 1);
+    total = result;
+  } else {
+    int fds[2];
+    if(pipe(fds) != 0){
+      perror("drive: pipe");
+      exit(2);
+    }
+    for(int job = 0; job < drive_jobs; job++){
+      pid_t pid = fork();
+      if(pid < 0){
+        perror("drive: fork");
+        exit(2);
+      }
+      if(pid == 0){
+        close(fds[0]);
+        run_share(job, drive_jobs);
+        if(write(fds[1], &result, sizeof(result)) != sizeof(result)) _exit(2);
+        _exit(0);
+      }
+    }
+    close(fds[1]);
+    drive_result part;
+    int parts = 0;
+    while(read(fds[0], &part, sizeof(part)) == sizeof(part)){
+      add(&total, &part);
+      parts++;
+    }
+    close(fds[0]);
+    int status;
+    while(wait(&status) > 0){
+      if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) parts = -1;
+    }
+    if(parts != drive_jobs){
+      fprintf(stderr, "drive: a worker crashed\n");
+      exit(2);
+    }
+  }
+  double secs = (drive_clock_ns() - t0) / 1e9;
+  result = total;
+  printf("%ld sequences, %ld keys, %ld mismatches, %ld uncertain, %ld resynced, %ld after a pause; %d jobs, %.0f keys/s, %.0f ns/press in handler\n",
+    total.sequences, total.keys, total.mismatches, total.uncertain, total.resyncs, total.pauses, drive_jobs,
+    total.keys / secs, total.keys ? (double)total.handler_ns / total.keys : 0.0);
+  if(drive_walk && total.walked > 0){
+    printf("predictor %s: %.3f cursor steps per keystroke over %ld keystrokes\n",
+      PREDICT ? "on" : "off", (double)total.steps / total.walked, total.walked);
+  }
+}
+
+static void load_script(const char* path){
+  FILE* f = fopen(path, "r");
+  if(f == NULL){
+    perror(path);
+    exit(2);
+  }
+  char line[DRIVE_MAX_KEYS];
+  while(fgets(line, sizeof(line), f) != NULL && script_count < DRIVE_MAX_SCRIPT){
+    char* hash = strchr(line, '#');
+    if(hash != NULL) *hash = 0;
+    char keys[DRIVE_MAX_KEYS];
+    int n = 0;
+    for(char* c = line; *c; c++){
+      if(strchr("0123456789.+-*/=C<", *c) != NULL) keys[n++] = *c;
+    }
+    keys[n] = 0;
+    if(n > 0) script_lines[script_count++] = strdup(keys);
+  }
+  fclose(f);
+}
+
+static void usage(){
+  fprintf(stderr, "usage: drive [-n sequences] [-j jobs] [-s seed] [-l maxlen] [-f script] [-r repeats] [--walk] [-v]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv){
+  for(int i = 1; i < argc; i++){
+    const char* a = argv[i];
+    if(strcmp(a, "--walk") == 0) drive_walk = true;
+    else if(strcmp(a, "-v") == 0) drive_verbose = true;
+    else if(i + 1 == argc) usage();
+    else if(strcmp(a, "-n") == 0) drive_n = atol(argv[++i]);
+    else if(strcmp(a, "-j") == 0) drive_jobs = atoi(argv[++i]);
+    else if(strcmp(a, "-s") == 0) drive_seed = strtoull(argv[++i], NULL, 0);
+    else if(strcmp(a, "-l") == 0) drive_maxlen = atoi(argv[++i]);
+    else if(strcmp(a, "-f") == 0) drive_script = argv[++i];
+    else if(strcmp(a, "-r") == 0) drive_repeats = atoi(argv[++i]);
+    else usage();
+  }
+  if(drive_maxlen < 1 || drive_maxlen > DRIVE_MAX_KEYS / 2) usage();
+  if(drive_jobs <= 0) drive_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  if(drive_jobs <= 0) drive_jobs = 1;
+  if(drive_script != NULL) load_script(drive_script);
+  if(drive_verbose) drive_jobs = 1;
+  stub_event_loop = drive;
+  rc_app_main();
+  return result.mismatches > 0 ? 1 : 0;
+}
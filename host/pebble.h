@@ -0,0 +1,113 @@
+#pragma once
+
+// Host stand-in for the parts of the Pebble SDK 2 API that src/main.c uses, so
+// the app can be built and driven on a workstation.  Layers and windows are
+// plain structs, time is a fake clock and timers fire when it is advanced;
+// see stub.h for the controls the host programs use.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct { int16_t x; int16_t y; } GPoint;
+typedef struct { int16_t w; int16_t h; } GSize;
+typedef struct { GPoint origin; GSize size; } GRect;
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+
+typedef struct GContext GContext;
+typedef struct Layer Layer;
+typedef struct TextLayer TextLayer;
+typedef struct InverterLayer InverterLayer;
+typedef struct Window Window;
+typedef struct AppTimer AppTimer;
+typedef void* ClickRecognizerRef;
+typedef const char* GFont;
+
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+typedef enum { BUTTON_ID_BACK, BUTTON_ID_UP, BUTTON_ID_SELECT, BUTTON_ID_DOWN, NUM_BUTTONS } ButtonId;
+
+typedef void (*LayerUpdateProc)(struct Layer* layer, GContext* ctx);
+typedef void (*WindowHandler)(Window* window);
+typedef struct { WindowHandler load; WindowHandler appear; WindowHandler disappear; WindowHandler unload; } WindowHandlers;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void* context);
+typedef void (*ClickConfigProvider)(void* context);
+typedef void (*AppTimerCallback)(void* data);
+
+typedef struct { int16_t x; int16_t y; int16_t z; bool did_vibrate; uint64_t timestamp; } AccelData;
+typedef enum { ACCEL_AXIS_X, ACCEL_AXIS_Y, ACCEL_AXIS_Z } AccelAxisType;
+typedef enum { ACCEL_SAMPLING_10HZ = 10, ACCEL_SAMPLING_25HZ = 25, ACCEL_SAMPLING_50HZ = 50, ACCEL_SAMPLING_100HZ = 100 } AccelSamplingRate;
+typedef void (*AccelDataHandler)(AccelData* data, uint32_t num_samples);
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+typedef void (*AppFocusHandler)(bool in_focus);
+
+#define FONT_KEY_GOTHIC_14 "GOTHIC_14"
+#define FONT_KEY_GOTHIC_18_BOLD "GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24_BOLD "GOTHIC_24_BOLD"
+
+typedef enum { APP_LOG_LEVEL_ERROR = 1, APP_LOG_LEVEL_WARNING = 50, APP_LOG_LEVEL_INFO = 100, APP_LOG_LEVEL_DEBUG = 200 } AppLogLevel;
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...);
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+Window* window_create(void);
+void window_destroy(Window* window);
+Layer* window_get_root_layer(const Window* window);
+void window_set_click_config_provider(Window* window, ClickConfigProvider provider);
+void window_set_window_handlers(Window* window, WindowHandlers handlers);
+void window_stack_push(Window* window, bool animated);
+Window* window_stack_pop(bool animated);
+Window* window_stack_get_top_window(void);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+
+void layer_add_child(Layer* parent, Layer* child);
+void layer_set_frame(Layer* layer, GRect frame);
+GRect layer_get_frame(const Layer* layer);
+void layer_set_hidden(Layer* layer, bool hidden);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer* layer);
+
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer* text_layer);
+Layer* text_layer_get_layer(TextLayer* text_layer);
+void text_layer_set_text(TextLayer* text_layer, const char* text);
+const char* text_layer_get_text(TextLayer* text_layer);
+void text_layer_set_font(TextLayer* text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment alignment);
+
+InverterLayer* inverter_layer_create(GRect frame);
+void inverter_layer_destroy(InverterLayer* inverter_layer);
+Layer* inverter_layer_get_layer(InverterLayer* inverter_layer);
+
+GFont fonts_get_system_font(const char* font_key);
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1);
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms);
+time_t stub_time(time_t* tloc);
+#define time(tloc) stub_time(tloc) // wall clock follows the fake clock
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+bool app_timer_reschedule(AppTimer* timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer* timer);
+
+int accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler);
+void accel_data_service_unsubscribe(void);
+int accel_service_set_sampling_rate(AccelSamplingRate rate);
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+#define PERSIST_DATA_MAX_LENGTH 256
+bool persist_exists(uint32_t key);
+int persist_read_data(uint32_t key, void* buffer, size_t buffer_size);
+int persist_write_data(uint32_t key, const void* data, size_t size);
+
+void app_event_loop(void);
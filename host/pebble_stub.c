@@ -0,0 +1,360 @@
+#include <stdarg.h>
+#include "stub.h"
+
+// Host stand-in for the Pebble SDK; see pebble.h.
+
+struct Layer{
+  GRect frame;
+  bool hidden;
+  LayerUpdateProc update_proc;
+};
+
+struct TextLayer{
+  Layer layer;
+  const char* text;
+  GFont font;
+  GTextAlignment alignment;
+};
+
+struct InverterLayer{
+  Layer layer;
+};
+
+struct Window{
+  Layer root;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config_provider;
+  ClickHandler clicks[NUM_BUTTONS];
+};
+
+struct AppTimer{
+  bool live;
+  uint64_t due;
+  AppTimerCallback callback;
+  void* data;
+};
+
+void (*stub_event_loop)(void) = NULL;
+bool stub_logging = false;
+
+#define STUB_WINDOW_STACK 8
+#define STUB_TIMERS 16
+#define STUB_PERSIST_KEYS 16
+
+static uint64_t now_ms = 1400000000000ULL; // an arbitrary date, so no timestamp is 0
+static Window* window_stack[STUB_WINDOW_STACK];
+static int window_stackn = 0;
+static AppTimer timers[STUB_TIMERS];
+static AccelDataHandler accel_handler = NULL;
+static AccelTapHandler tap_handler = NULL;
+static AppFocusHandler focus_handler = NULL;
+
+static struct{
+  bool used;
+  uint32_t key;
+  size_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} persist[STUB_PERSIST_KEYS];
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...){
+  if(!stub_logging) return;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s:%d ", src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+// windows and clicks
+
+static void configure_clicks(Window* window){
+  memset(window->clicks, 0, sizeof(window->clicks));
+  if(window->click_config_provider != NULL) window->click_config_provider(window);
+}
+
+Window* window_create(void){
+  return calloc(1, sizeof(Window));
+}
+
+void window_destroy(Window* window){
+  free(window);
+}
+
+Layer* window_get_root_layer(const Window* window){
+  return (Layer*)&(window->root);
+}
+
+void window_set_click_config_provider(Window* window, ClickConfigProvider provider){
+  window->click_config_provider = provider;
+  if(window_stack_get_top_window() == window) configure_clicks(window);
+}
+
+void window_set_window_handlers(Window* window, WindowHandlers handlers){
+  window->handlers = handlers;
+}
+
+void window_stack_push(Window* window, bool animated){
+  Window* top = window_stack_get_top_window();
+  if(top != NULL && top->handlers.disappear != NULL) top->handlers.disappear(top);
+  if(window_stackn == STUB_WINDOW_STACK){
+    fprintf(stderr, "stub: window stack overflow\n");
+    abort();
+  }
+  window_stack[window_stackn++] = window;
+  if(window->handlers.load != NULL) window->handlers.load(window);
+  configure_clicks(window);
+  if(window->handlers.appear != NULL) window->handlers.appear(window);
+}
+
+Window* window_stack_pop(bool animated){
+  if(window_stackn == 0) return NULL;
+  Window* window = window_stack[--window_stackn];
+  if(window->handlers.disappear != NULL) window->handlers.disappear(window);
+  if(window->handlers.unload != NULL) window->handlers.unload(window);
+  Window* top = window_stack_get_top_window();
+  if(top != NULL){
+    configure_clicks(top);
+    if(top->handlers.appear != NULL) top->handlers.appear(top);
+  }
+  return window;
+}
+
+Window* window_stack_get_top_window(void){
+  return (window_stackn > 0) ? window_stack[window_stackn - 1] : NULL;
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler){
+  Window* top = window_stack_get_top_window();
+  if(top != NULL) top->clicks[button_id] = handler;
+}
+
+bool stub_click(ButtonId button_id){
+  Window* top = window_stack_get_top_window();
+  if(top == NULL || top->clicks[button_id] == NULL) return false;
+  top->clicks[button_id](NULL, top);
+  return true;
+}
+
+// layers
+
+void layer_add_child(Layer* parent, Layer* child){
+}
+
+void layer_set_frame(Layer* layer, GRect frame){
+  layer->frame = frame;
+}
+
+GRect layer_get_frame(const Layer* layer){
+  return layer->frame;
+}
+
+void layer_set_hidden(Layer* layer, bool hidden){
+  layer->hidden = hidden;
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc){
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer* layer){
+}
+
+TextLayer* text_layer_create(GRect frame){
+  TextLayer* text_layer = calloc(1, sizeof(TextLayer));
+  if(text_layer != NULL) text_layer->layer.frame = frame;
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer* text_layer){
+  free(text_layer);
+}
+
+Layer* text_layer_get_layer(TextLayer* text_layer){
+  return &(text_layer->layer);
+}
+
+void text_layer_set_text(TextLayer* text_layer, const char* text){
+  text_layer->text = text;
+}
+
+const char* text_layer_get_text(TextLayer* text_layer){
+  return text_layer->text;
+}
+
+void text_layer_set_font(TextLayer* text_layer, GFont font){
+  text_layer->font = font;
+}
+
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment alignment){
+  text_layer->alignment = alignment;
+}
+
+InverterLayer* inverter_layer_create(GRect frame){
+  InverterLayer* inverter_layer = calloc(1, sizeof(InverterLayer));
+  if(inverter_layer != NULL) inverter_layer->layer.frame = frame;
+  return inverter_layer;
+}
+
+void inverter_layer_destroy(InverterLayer* inverter_layer){
+  free(inverter_layer);
+}
+
+Layer* inverter_layer_get_layer(InverterLayer* inverter_layer){
+  return &(inverter_layer->layer);
+}
+
+GFont fonts_get_system_font(const char* font_key){
+  return font_key;
+}
+
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1){
+}
+
+// time and timers
+
+uint64_t stub_now_ms(void){
+  return now_ms;
+}
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms){
+  if(tloc != NULL) *tloc = now_ms / 1000;
+  if(out_ms != NULL) *out_ms = now_ms % 1000;
+  return now_ms % 1000;
+}
+
+time_t stub_time(time_t* tloc){
+  time_t t = now_ms / 1000;
+  if(tloc != NULL) *tloc = t;
+  return t;
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data){
+  for(int i = 0; i < STUB_TIMERS; i++){
+    if(!timers[i].live){
+      timers[i].live = true;
+      timers[i].due = now_ms + timeout_ms;
+      timers[i].callback = callback;
+      timers[i].data = callback_data;
+      return &timers[i];
+    }
+  }
+  return NULL;
+}
+
+bool app_timer_reschedule(AppTimer* timer, uint32_t new_timeout_ms){
+  if(!timer->live) return false;
+  timer->due = now_ms + new_timeout_ms;
+  return true;
+}
+
+void app_timer_cancel(AppTimer* timer){
+  timer->live = false;
+}
+
+void stub_advance(uint32_t ms){
+  uint64_t end = now_ms + ms;
+  for(;;){
+    AppTimer* next = NULL;
+    for(int i = 0; i < STUB_TIMERS; i++){
+      if(timers[i].live && timers[i].due <= end && (next == NULL || timers[i].due < next->due)) next = &timers[i];
+    }
+    if(next == NULL) break;
+    if(next->due > now_ms) now_ms = next->due;
+    next->live = false;
+    next->callback(next->data);
+  }
+  now_ms = end;
+}
+
+// services
+
+int accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler){
+  accel_handler = handler;
+  return 0;
+}
+
+void accel_data_service_unsubscribe(void){
+  accel_handler = NULL;
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate){
+  return 0;
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler){
+  tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void){
+  tap_handler = NULL;
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler){
+  focus_handler = handler;
+}
+
+void app_focus_service_unsubscribe(void){
+  focus_handler = NULL;
+}
+
+bool stub_accel(AccelData* data, uint32_t num_samples){
+  if(accel_handler == NULL) return false;
+  accel_handler(data, num_samples);
+  return true;
+}
+
+void stub_tap(void){
+  if(tap_handler != NULL) tap_handler(ACCEL_AXIS_X, 1);
+}
+
+void stub_focus(bool in_focus){
+  if(focus_handler != NULL) focus_handler(in_focus);
+}
+
+size_t heap_bytes_used(void){
+  return 0;
+}
+
+size_t heap_bytes_free(void){
+  return 0;
+}
+
+// persistent storage, kept in memory for the life of the process
+
+static int persist_find(uint32_t key){
+  for(int i = 0; i < STUB_PERSIST_KEYS; i++){
+    if(persist[i].used && persist[i].key == key) return i;
+  }
+  return -1;
+}
+
+bool persist_exists(uint32_t key){
+  return persist_find(key) >= 0;
+}
+
+int persist_read_data(uint32_t key, void* buffer, size_t buffer_size){
+  int i = persist_find(key);
+  if(i < 0) return -1;
+  size_t n = (buffer_size < persist[i].size) ? buffer_size : persist[i].size;
+  memcpy(buffer, persist[i].data, n);
+  return n;
+}
+
+int persist_write_data(uint32_t key, const void* data, size_t size){
+  if(size > PERSIST_DATA_MAX_LENGTH) size = PERSIST_DATA_MAX_LENGTH;
+  int i = persist_find(key);
+  for(int j = 0; i < 0 && j < STUB_PERSIST_KEYS; j++){
+    if(!persist[j].used) i = j;
+  }
+  if(i < 0) return -1;
+  persist[i].used = true;
+  persist[i].key = key;
+  persist[i].size = size;
+  memcpy(persist[i].data, data, size);
+  return size;
+}
+
+void app_event_loop(void){
+  if(stub_event_loop != NULL) stub_event_loop();
+}
@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "reference.h"
+
+// Relative error of one float operation, with a factor of two to spare.
+#define REF_EPS (1.0L / (1 << 23))
+#define REF_FRACTION_DIGITS 6 // FRACTION_DIGITS in src/main.c
+
+static const ref_num ref_zero = {0, 0};
+
+/**
+ * Value of a display string read the way rc_get_number_value reads it, but exactly.
+ */
+static long double ref_parse(const char* num){
+  int len = strlen(num);
+  int dot = len;
+  bool neg = false;
+  long double val = 0;
+  for(int i = 0; i < len; i++){
+    if(num[i] == '.') dot = i;
+  }
+  for(int i = 0; i < dot; i++){
+    if(num[i] == '-') neg = true;
+    else if(num[i] >= '0' && num[i] <= '9') val += (num[i] - '0') * powl(10, dot - i - 1);
+  }
+  for(int i = dot + 1; i < len; i++){
+    if(num[i] >= '0' && num[i] <= '9') val += (num[i] - '0') / powl(10, i - dot);
+  }
+  return neg ? -val : val;
+}
+
+/**
+ * Bound on the error of the app's float parse of a display of len characters:
+ * each digit costs a power of ten, a product or quotient and a sum.
+ */
+static long double ref_parse_err(long double v, int len){
+  return (3 * len + 4) * REF_EPS * fabsl(v);
+}
+
+/**
+ * Bound on how far the app's display text can be from its float value: the
+ * fraction is rounded to six places and cut short when the buffer is full.
+ */
+static long double ref_format_err(const ref_num* n){
+  long double hi = fabsl(n->v) + n->err;
+  int whole = 1;
+  for(long double p = 10; p <= hi; p *= 10) whole++;
+  int sign = (n->v - n->err < 0) ? 1 : 0;
+  int room = (REF_DISPLAY_SIZE - 1) - sign - whole - 1; // fraction digits that fit after the dot
+  long double cut = 0;
+  if(room < REF_FRACTION_DIGITS) cut = (room > 0) ? powl(10, -room) : 1;
+  return 5e-7L + 1e-7L + cut;
+}
+
+static bool ref_all_zero(const char* num){
+  for(const char* c = num; *c; c++){
+    if(*c >= '1' && *c <= '9') return false;
+  }
+  return true;
+}
+
+/**
+ * The number the app reads back from its display, with its error bound.
+ */
+static ref_num ref_display_value(const ref_calc* r){
+  ref_num n;
+  if(!r->computed){
+    n.v = ref_parse(r->entry);
+    n.err = ref_parse_err(n.v, strlen(r->entry));
+  } else if(r->e){
+    n = ref_zero; // "E" reads as 0
+  } else {
+    n = r->result;
+    n.err += ref_format_err(&(r->result));
+    n.err += ref_parse_err(fabsl(n.v) + n.err, REF_DISPLAY_SIZE - 1);
+  }
+  return n;
+}
+
+static void ref_round(ref_num* n){
+  n->err += (fabsl(n->v) + n->err) * REF_EPS;
+}
+
+static ref_status ref_apply(char op, ref_num a, ref_num b, ref_num* res){
+  switch(op){
+    case '+':
+      res->v = a.v + b.v;
+      res->err = a.err + b.err;
+      break;
+    case '-':
+      res->v = a.v - b.v;
+      res->err = a.err + b.err;
+      break;
+    case '*':
+      res->v = a.v * b.v;
+      res->err = fabsl(a.v) * b.err + fabsl(b.v) * a.err + a.err * b.err;
+      break;
+    case '/':
+      if(b.v == 0 && b.err == 0){ // the app shows 0 for a division by zero
+        *res = ref_zero;
+        return REF_OK;
+      }
+      if(fabsl(b.v) <= b.err) return REF_UNCERTAIN; // the app's divisor may or may not be 0
+      res->v = a.v / b.v;
+      res->err = (fabsl(a.v) * b.err + fabsl(b.v) * a.err) / (fabsl(b.v) * (fabsl(b.v) - b.err));
+      break;
+  }
+  ref_round(res);
+  return REF_OK;
+}
+
+/**
+ * Show a computed value, unless the app's float could land on either side of
+ * the "E" limit or overflow.
+ */
+static ref_status ref_show(ref_calc* r, ref_num res){
+  long double lo = fabsl(res.v) - res.err, hi = fabsl(res.v) + res.err;
+  if(lo < REF_E_LIMIT && hi >= REF_E_LIMIT) return REF_UNCERTAIN;
+  if(hi >= 3e38L) return REF_UNCERTAIN; // the float may be inf
+  r->computed = true;
+  r->result = res;
+  r->e = lo >= REF_E_LIMIT;
+  return REF_OK;
+}
+
+/**
+ * A digit or dot after an operator or '=' starts a new number.
+ */
+static void ref_start_entry(ref_calc* r){
+  if(r->state == REF_TYPING) return;
+  if(r->state == REF_AFTER_EQU){ // a new calculation
+    r->pending = 0;
+    r->op[0] = 0;
+  }
+  r->computed = false;
+  strcpy(r->entry, "0");
+  r->state = REF_TYPING;
+}
+
+void ref_reset(ref_calc* r){
+  memset(r, 0, sizeof(ref_calc));
+  r->state = REF_AFTER_EQU;
+  strcpy(r->entry, "0");
+}
+
+ref_status ref_press(ref_calc* r, char key){
+  ref_num res;
+  if(key >= '0' && key <= '9'){
+    ref_start_entry(r);
+    int len = strlen(r->entry);
+    if(ref_all_zero(r->entry) && strchr(r->entry, '.') == NULL){ // a leading zero is replaced
+      r->entry[0] = key;
+      r->entry[1] = 0;
+    } else if(len + 1 < REF_DISPLAY_SIZE){
+      r->entry[len] = key;
+      r->entry[len + 1] = 0;
+    }
+    return REF_OK;
+  }
+  switch(key){
+    case '.':
+      ref_start_entry(r);
+      if(strchr(r->entry, '.') == NULL && strlen(r->entry) + 1 < REF_DISPLAY_SIZE) strcat(r->entry, ".");
+      return REF_OK;
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+      if(r->state == REF_TYPING && r->pending){ // 2+3* shows 5 and goes on from it
+        if(ref_apply(r->pending, r->acc, ref_display_value(r), &res) != REF_OK) return REF_UNCERTAIN;
+        if(ref_show(r, res) != REF_OK) return REF_UNCERTAIN;
+        r->acc = res;
+      } else if(r->state != REF_AFTER_OP){
+        r->acc = ref_display_value(r);
+      }
+      r->pending = key;
+      r->op[0] = key;
+      r->op[1] = 0;
+      r->state = REF_AFTER_OP;
+      return REF_OK;
+    case '=':
+      if(!r->pending) return REF_OK;
+      if(r->state == REF_AFTER_EQU){ // repeat the last operation on the result
+        if(ref_apply(r->pending, ref_display_value(r), r->operand, &res) != REF_OK) return REF_UNCERTAIN;
+      } else {
+        r->operand = ref_display_value(r);
+        if(ref_apply(r->pending, r->acc, r->operand, &res) != REF_OK) return REF_UNCERTAIN;
+      }
+      if(ref_show(r, res) != REF_OK) return REF_UNCERTAIN;
+      r->state = REF_AFTER_EQU;
+      return REF_OK;
+    case 'C':
+      ref_reset(r);
+      return REF_OK;
+    case '<':
+      if(r->computed) return REF_RESYNC; // the app edits the text of a result we only know approximately
+      int n = strlen(r->entry);
+      if(n > 1) r->entry[n - 1] = 0;
+      else strcpy(r->entry, "0");
+      if(strcmp(r->entry, "-") == 0) strcpy(r->entry, "0");
+      return REF_OK;
+  }
+  return REF_UNCERTAIN;
+}
+
+void ref_resync(ref_calc* r, const char* display){
+  r->computed = false;
+  snprintf(r->entry, REF_DISPLAY_SIZE, "%s", display);
+}
+
+bool ref_check(const ref_calc* r, const char* display, const char* op, char* why, size_t why_size){
+  if(strcmp(op, r->op) != 0){
+    snprintf(why, why_size, "operator display \"%s\", expected \"%s\"", op, r->op);
+    return false;
+  }
+  if(!r->computed){
+    if(strcmp(display, r->entry) != 0){
+      snprintf(why, why_size, "display \"%s\", expected \"%s\"", display, r->entry);
+      return false;
+    }
+  } else if(r->e){
+    if(strcmp(display, "E") != 0){
+      snprintf(why, why_size, "display \"%s\", expected \"E\" for %.12Lg", display, r->result.v);
+      return false;
+    }
+  } else {
+    long double bound = r->result.err + ref_format_err(&(r->result));
+    long double d = ref_parse(display);
+    if(strcmp(display, "E") == 0 || fabsl(d - r->result.v) > bound){
+      snprintf(why, why_size, "display \"%s\", expected %.12Lg +/- %.3Lg", display, r->result.v, bound);
+      return false;
+    }
+  }
+  return true;
+}
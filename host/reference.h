@@ -0,0 +1,56 @@
+#pragma once
+
+// Reference evaluator for the keystroke driver.
+//
+// A plain left-to-right calculator written from what the keys should do, not
+// from select_click_handler: an operator first applies the one pending, so
+// 5+5+5= is 15, and '=' again repeats the last operation on the result.  It
+// only looks at what the user sees (the number and operator displays), does
+// arithmetic in long double and carries a bound on the error the app's float
+// arithmetic, parsing and display formatting can introduce.  A display is only
+// reported as wrong when it falls outside that bound.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define REF_DISPLAY_SIZE 16 // GLOBAL_BUFFER_SIZE in src/main.c
+#define REF_E_LIMIT 1e9L    // results this large show "E"
+
+typedef struct{
+  long double v;
+  long double err; // |app value - v| <= err
+} ref_num;
+
+typedef enum{
+  REF_TYPING,   // digits add to the number shown
+  REF_AFTER_OP, // an operator was pressed; a digit starts its right operand
+  REF_AFTER_EQU // '=' (or C, or launch); a digit starts a new calculation
+} ref_state;
+
+typedef struct{
+  ref_state state;
+  char pending;    // operator waiting for its right operand: '+', '-', '*', '/' or 0
+  ref_num acc;     // left operand of the pending operator
+  ref_num operand; // right operand of the last '=', which '=' again reuses
+  char op[2];      // operator display
+  bool computed;   // display holds a result rather than typed text
+  char entry[REF_DISPLAY_SIZE]; // display text, when !computed
+  ref_num result;  // when computed
+  bool e;          // the result showed "E"
+} ref_calc;
+
+typedef enum{
+  REF_OK,
+  REF_RESYNC,   // the key edited a computed display; call ref_resync with the app's text
+  REF_UNCERTAIN // the app's float result can't be predicted (e.g. divisor within error of 0)
+} ref_status;
+
+void ref_reset(ref_calc* r);
+// Apply one key: 0-9 . + - * / = C, or '<' for backspace.
+ref_status ref_press(ref_calc* r, char key);
+// Adopt the app's display text, after an edit the model can't follow exactly or
+// once a result has passed ref_check, so later keys read what the app shows.
+void ref_resync(ref_calc* r, const char* display);
+// Compare the app's number and operator displays with the model.  On a
+// mismatch writes a description into why and returns false.
+bool ref_check(const ref_calc* r, const char* display, const char* op, char* why, size_t why_size);
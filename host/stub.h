@@ -0,0 +1,20 @@
+#pragma once
+
+// Controls for the host stand-in SDK in pebble_stub.c.
+
+#include "pebble.h"
+
+extern void (*stub_event_loop)(void); // run by app_event_loop(), in place of the watch's loop
+extern bool stub_logging;             // print APP_LOG output to stderr
+
+uint64_t stub_now_ms(void);
+// Move the fake clock forward, firing every timer that falls due on the way.
+void stub_advance(uint32_t ms);
+
+// Invoke the handler the top window's click config provider subscribed for button_id.
+// Returns false when nothing is subscribed.
+bool stub_click(ButtonId button_id);
+// Deliver a batch to the accelerometer subscriber, if there is one.
+bool stub_accel(AccelData* data, uint32_t num_samples);
+void stub_tap(void);
+void stub_focus(bool in_focus);
@@ -9,7 +9,6 @@
 #define BUF_SIZE_BUTTON 5
 #define BUF_SIZE_NUMBER 64
 #define ARRAY_SIZE_BUTTONS 32
-#define BUF_SIZE_DEBUG 256
 #define SCREEN_WIDTH 144
 #define SCREEN_HEIGHT 168
 #define STATUSBAR_HEIGHT 16
@@ -44,8 +43,24 @@
 #define CALC_NUM_INITIAL  "0" // initial string for number display
 #define CALC_OP_INITIAL  "" // initial string for operator display
   
-bool LOGGING = false; // turning off logging seems to increase stability
-bool DEBUG = false;
+// Build variants are chosen in the wscript (--rc-build=release|debug|profiling).
+// The switches are constants so the compiler drops whatever a variant leaves out.
+#if defined(RC_BUILD_DEBUG)
+#define LOGGING 1
+#define DEBUG 1
+#define PROFILING 0
+#elif defined(RC_BUILD_PROFILING)
+#define LOGGING 0
+#define DEBUG 0
+#define PROFILING 1 // rolling CPU and heap stats in the debug overlay, dumped to the log on exit
+#else
+#define LOGGING 0 // turning off logging seems to increase stability
+#define DEBUG 0
+#define PROFILING 0
+#endif
+#ifndef PREDICT // set by the wscript's --rc-predict
+#define PREDICT 0 // jump the cursor to the most likely next key after each press
+#endif
 
 // global memory for things linked to GUI b/c it has a hard time w the heap
 // these resources are allocated once by ID and not released until cleanup
@@ -64,9 +79,9 @@ InverterLayer* _invlayers[GLOBAL_INVLAYER_COUNT];
 int _invlayersn = 0;
 
 void init_global_resources(){
-  memset(_windows, 0, GLOBAL_WINDOW_COUNT);
-  memset(_textlayers, 0, GLOBAL_TEXTLAYER_COUNT);
-  memset(_invlayers, 0, GLOBAL_INVLAYER_COUNT);  
+  memset(_windows, 0, sizeof(_windows));
+  memset(_textlayers, 0, sizeof(_textlayers));
+  memset(_invlayers, 0, sizeof(_invlayers));
 }
 
 // Trying to see if callback is barfing the destructor.
@@ -77,42 +92,41 @@ bool shutdown = false;
 // debug display
 TextLayer* tl_debug;
 char tl_debug_buf[256];
-char buf_debug[BUF_SIZE_DEBUG]; // used as temp space for writing to logger
 char tl_debug_buf2[256];
 
 int getWindow(){
   _windows[_windowsn] = window_create();
   if(_windows[_windowsn] == NULL){
-    snprintf(buf_debug, BUF_SIZE_DEBUG, "Unable to create _window %d", _windowsn); APP_LOG(APP_LOG_LEVEL_ERROR, buf_debug);    
+    if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Unable to create _window %d", _windowsn);
     return -1;
   }
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Got _window %d", _windowsn); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);  
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Got _window %d", _windowsn);
   return _windowsn++;
 }
 
 int getInvlayer(GRect rect){
   _invlayers[_invlayersn] = inverter_layer_create(rect);
   if(_invlayers[_invlayersn] == NULL){
-    snprintf(buf_debug, BUF_SIZE_DEBUG, "Unable to create _invlayer %d", _invlayersn); APP_LOG(APP_LOG_LEVEL_ERROR, buf_debug);    
+    if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Unable to create _invlayer %d", _invlayersn);
     return -1;
   }
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Got _invlayer %d", _invlayersn); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);  
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Got _invlayer %d", _invlayersn);
   return _invlayersn++;
 }
 
 int getTextlayer(GRect rect){
   _textlayers[_textlayersn] = text_layer_create(rect);
   if(_textlayers[_textlayersn] == NULL){
-    snprintf(buf_debug, BUF_SIZE_DEBUG, "Unable to create _textlayer %d", _textlayersn); APP_LOG(APP_LOG_LEVEL_ERROR, buf_debug);    
+    if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Unable to create _textlayer %d", _textlayersn);
     return -1;
   }
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Got _textlayer %d", _textlayersn); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);  
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Got _textlayer %d", _textlayersn);
   return _textlayersn++;
 }
 
 int getBuffer(){
   memset(_buffers[_buffersn], 0, GLOBAL_BUFFER_SIZE);
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Got _buffer %d", _buffersn); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);  
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Got _buffer %d", _buffersn);
   return _buffersn++;
 }
 
@@ -127,13 +141,22 @@ typedef struct{
   int y;
 } rc_vector2;
 
-#define SMOOTHER_BUF_SIZE_MAX 128
+// Window sizes are powers of two fixed at compile time, so wrapping the ring is a
+// mask and averaging is a divide by a constant power of two, which the compiler
+// turns into a shift (plus a sign fixup, since it rounds toward zero).
+#ifndef SMOOTHER_FAST_BITS
+#define SMOOTHER_FAST_BITS 2 // 4 samples
+#endif
+#ifndef SMOOTHER_SLOW_BITS
+#define SMOOTHER_SLOW_BITS 6 // 64 samples
+#endif
+#define RC_INLINE static inline __attribute__((always_inline))
+
+// Smoothers are always seeded before use (see sampler_reseed), so the window is always full.
 typedef struct{
-  int n;
   int p;
-  int buf[SMOOTHER_BUF_SIZE_MAX];
+  int* buf; // 1 << bits samples
   int sum;  
-  int size;
 } rc_smoother;
 
 
@@ -143,34 +166,53 @@ typedef struct{
   rc_smoother sz;
 } rc_smoothvector3;
 
-void rc_setup_smoothvector3(rc_smoothvector3* s, int size){
-  if(size > SMOOTHER_BUF_SIZE_MAX) size = SMOOTHER_BUF_SIZE_MAX;
+/**
+ * storage must hold 3 << bits ints.
+ */
+void rc_setup_smoothvector3(rc_smoothvector3* s, int* storage, int bits){
   memset(s, 0, sizeof(rc_smoothvector3));
-  s->sx.size = size;
-  s->sy.size = size;
-  s->sz.size = size;
+  memset(storage, 0, (3 << bits) * sizeof(int));
+  s->sx.buf = storage;
+  s->sy.buf = storage + (1 << bits);
+  s->sz.buf = storage + (2 << bits);
 }
 
-void rc_update_smoother(rc_smoother* s, int sample){
-  if(s->n < s->size) s->n++;
+RC_INLINE void rc_update_smoother(rc_smoother* s, int sample, const int bits){
   s->sum -= s->buf[s->p];  
   s->buf[s->p] = sample;
   s->sum += sample;
-  s->p = (s->p+1) % s->size;
+  s->p = (s->p+1) & ((1 << bits) - 1);
+}
+
+/**
+ * Fill the whole window with one sample, so the average starts at the current reading.
+ */
+RC_INLINE void rc_seed_smoother(rc_smoother* s, int sample, const int bits){
+  for(int i = 0; i < (1 << bits); i++){
+    s->buf[i] = sample;
+  }
+  s->sum = sample * (1 << bits); // samples are often negative, so no shift
+  s->p = 0;
 }
 
-int rc_get_smoother_value(rc_smoother* s){
-  if(s->n == 0) return 0;
-  return s->sum / s->n;
+RC_INLINE int rc_get_smoother_value(rc_smoother* s, const int bits){
+  return s->sum / (1 << bits);
 }
 
-void rc_update_smoothvector3(rc_smoothvector3* sv, AccelData* ad, uint32_t num_samples){
+RC_INLINE void rc_update_smoothvector3(rc_smoothvector3* sv, AccelData* ad, uint32_t num_samples, const int bits){
   for(uint32_t i = 0; i < num_samples; i++){
-    rc_update_smoother(&(sv->sx), ad[i].x);
-    rc_update_smoother(&(sv->sy), ad[i].y);
-    rc_update_smoother(&(sv->sz), ad[i].z);
+    rc_update_smoother(&(sv->sx), ad[i].x, bits);
+    rc_update_smoother(&(sv->sy), ad[i].y, bits);
+    rc_update_smoother(&(sv->sz), ad[i].z, bits);
   }
 }
+RC_INLINE void rc_seed_smoothvector3(rc_smoothvector3* sv, AccelData* ad, const int bits){
+  rc_seed_smoother(&(sv->sx), ad->x, bits);
+  rc_seed_smoother(&(sv->sy), ad->y, bits);
+  rc_seed_smoother(&(sv->sz), ad->z, bits);
+}
+int vslow_buf[3 << SMOOTHER_SLOW_BITS];
+int vfast_buf[3 << SMOOTHER_FAST_BITS];
 rc_smoothvector3 vslow;
 rc_smoothvector3 vfast;
 //rc_vector3 vbase = {.x=0, .y=0, .z=0}; 
@@ -179,7 +221,11 @@ rc_vector3 vdiff = {.x=0, .y=0, .z=0};
 //rc_vector2 vtilt = {.x=0, .y=0};
 int tilt=0;
 uint64_t tilt_time=0;
-uint16_t scan_time=0;
+uint16_t scan_time=0;     // duration of the last sampler callback in millis
+uint16_t scan_time_max=0; // longest sampler callback seen
+int sampler_batches=0;    // batches delivered to the sampler
+int sampler_dropped=0;    // batches lost, judged by gaps in the sample timestamps
+uint64_t sample_time=0;   // timestamp of the newest sample seen
 /*  fast inverse sqrt code from Quake 3, won't compile on cloudpebble
 float Q_rsqrt( float number )
 {
@@ -206,6 +252,7 @@ typedef struct{
   int bufid; // ID of the buffer for the label
   int type;
   int value;
+  int id;    // index in the buttonset
 } rc_button;
   
 typedef struct{
@@ -222,6 +269,20 @@ typedef struct{
   int y;
 } rc_cursor;
 
+// Completed results are kept in a fixed ring and persisted as a single blob,
+// so memory stays the same however many calculations are made.
+#define HISTORY_CAPACITY 32
+#define HISTORY_ROWS 6 // rows visible in the history window, one textlayer each
+#define HISTORY_ROW_HEIGHT 24
+#define PERSIST_KEY_HISTORY 1
+typedef struct{
+  int16_t head;  // slot the next result is written to
+  int16_t count; // stored results, up to HISTORY_CAPACITY
+  float values[HISTORY_CAPACITY];
+} rc_history;
+
+rc_history history;
+
 typedef struct{
   rc_buttonset* buttonset;
   int tlid_op; // id of textlayer for currect operator display
@@ -233,6 +294,12 @@ typedef struct{
   float tmpval; // value in temporary memory
   int tmpop;    // operator ready
   int mode;     // state of the calculator
+  int winid_history; // window id of the history tape
+  int tlid_history[HISTORY_ROWS]; // ids of textlayers for the visible history rows
+  int bufid_history[HISTORY_ROWS]; // ids of buffers for the visible history rows
+  int invid_history; // id of invlayer highlighting the selected row
+  int history_sel; // selected entry, 0 is the newest
+  int history_top; // entry shown in the first row
 } rc_calculator;
 
 // global pointer to calculator
@@ -244,7 +311,182 @@ rc_calculator* calc = NULL;
 #define THRESH_TILT_X 75 // milliG to trigger tilt
 #define THRESH_TILT_Y 75 // milliG to trigger tilt
 #define THRESH_TIME 0 // millis between cursor moves  
+#define ACCEL_SAMPLES_PER_BATCH 4
+#define ACCEL_SAMPLE_PERIOD_MS 20 // 50Hz
+
+// The sampler only records what changed; drawing happens in a frame timer so a
+// slow redraw can't hold up the next batch of samples.
+#define FRAME_INTERVAL_MS 40 // caps UI flushes at 25 fps
+AppTimer* frame_timer = NULL;
+uint64_t frame_time = 0;         // time of the last flush
+bool frame_dirty_cursor = false; // cursor moved since the last flush
+bool frame_dirty_debug = false;  // debug text is stale
+int frame_count = 0;             // frames flushed
+int frame_coalesced = 0;         // changes folded into an already pending frame
+
+// The sampler is suspended while the app is out of focus or the cursor has sat
+// still for IDLE_TIMEOUT_MS, and resumed on focus, a wrist flick or a button press.
+#define IDLE_TIMEOUT_MS 30000
+bool sampler_active = false;
+bool sampler_reseed = false; // seed the smoothers from the first batch after a resume
+bool app_in_focus = true;    // taps don't wake the sampler while something covers the app
+AppTimer* idle_timer = NULL;
+uint64_t activity_time = 0;  // last cursor move or button press
+uint64_t suspend_time = 0;   // when the current suspension began
+uint64_t suspended_ms = 0;   // total time spent suspended
+int suspend_count = 0;
+Window* sampler_window = NULL; // the sampler only runs while this window is on top
+void rc_sampler_resume();
+
+/**
+ * Millisecond clock for measuring durations.
+ */
+uint64_t rc_now_ms(){
+  time_t s;
+  uint16_t ms;
+  time_ms(&s, &ms);
+  return (uint64_t)s * 1000 + ms;
+}
+
+// Profiling keeps one bucket per second for the last PROFILE_WINDOW seconds,
+// so the overlay shows rates over a fixed window without growing.
+#define PROFILE_WINDOW 8 // seconds
+typedef struct{
+  int callbacks;  // sampler callbacks
+  int sampler_ms; // busy millis in the sampler
+  int clicks;     // click handler calls
+  int click_ms;   // busy millis in the click handlers
+  int frames;     // UI flushes
+} rc_profile_bucket;
+
+typedef struct{
+  rc_profile_bucket buckets[PROFILE_WINDOW];
+  int p;         // bucket for the current second
+  int n;         // completed seconds in the window
+  time_t second; // second the current bucket covers
+  int heap_max;  // heap high-water mark in bytes
+} rc_profiler;
+
+rc_profiler profiler;
+
+/**
+ * Return the bucket for the current second, rolling the window forward if needed.
+ * Sets frame_dirty_debug when a second completes so the overlay gets refreshed.
+ */
+rc_profile_bucket* rc_profile_tick(){
+  time_t now = time(NULL);
+  if(profiler.second == 0) profiler.second = now;
+  if(now > profiler.second){
+    int k = now - profiler.second;
+    if(k > PROFILE_WINDOW) k = PROFILE_WINDOW;
+    for(int i = 0; i < k; i++){
+      profiler.p = (profiler.p + 1) % PROFILE_WINDOW;
+      memset(&(profiler.buckets[profiler.p]), 0, sizeof(rc_profile_bucket));
+    }
+    profiler.n += k;
+    if(profiler.n > PROFILE_WINDOW - 1) profiler.n = PROFILE_WINDOW - 1;
+    profiler.second = now;
+    frame_dirty_debug = true;
+  }
+  int heap = heap_bytes_used();
+  if(heap > profiler.heap_max) profiler.heap_max = heap;
+  return &(profiler.buckets[profiler.p]);
+}
+
+/**
+ * Average the completed seconds of the window into a single per-second bucket.
+ */
+void rc_profile_rates(rc_profile_bucket* out){
+  memset(out, 0, sizeof(rc_profile_bucket));
+  if(profiler.n == 0) return;
+  for(int i = 1; i <= profiler.n; i++){
+    rc_profile_bucket* b = &(profiler.buckets[(profiler.p - i + PROFILE_WINDOW) % PROFILE_WINDOW]);
+    out->callbacks += b->callbacks;
+    out->sampler_ms += b->sampler_ms;
+    out->clicks += b->clicks;
+    out->click_ms += b->click_ms;
+    out->frames += b->frames;
+  }
+  out->callbacks /= profiler.n;
+  out->sampler_ms /= profiler.n;
+  out->clicks /= profiler.n;
+  out->click_ms /= profiler.n;
+  out->frames /= profiler.n;
+}
+
+void rc_format_profile(char* buf, int size){
+  rc_profile_bucket r;
+  rc_profile_rates(&r);
+  snprintf(buf, size, "cb%d s%d c%d/%d f%d h%d", r.callbacks, r.sampler_ms, r.clicks, r.click_ms, r.frames, profiler.heap_max);
+}
+
+/**
+ * Count a click handler call that started at t0.
+ */
+void rc_profile_click(uint64_t t0){
+  if(!PROFILING) return;
+  rc_profile_bucket* b = rc_profile_tick();
+  b->clicks++;
+  b->click_ms += rc_now_ms() - t0;
+}
+
+void rc_flush_frame(void* data){
+  frame_timer = NULL;
+  if(shutdown) return;
+  if(frame_dirty_cursor){
+    layer_set_frame(inverter_layer_get_layer(_invlayers[calc->cursor.invid]),
+      GRect(calc->cursor.x, calc->cursor.y, SIZE_BUTTON_X, SIZE_BUTTON_Y));
+    frame_dirty_cursor = false;
+  }
+  if(frame_dirty_debug){
+    if(PROFILING){
+      rc_format_profile(tl_debug_buf, 256);
+    } else {
+      snprintf(tl_debug_buf, 256, "x%dy%dz%d t%d %dms d%d", vdiff.x, vdiff.y, vdiff.z, tilt, scan_time_max, sampler_dropped);
+      strcat(tl_debug_buf, tl_debug_buf2);
+    }
+    text_layer_set_text(tl_debug, tl_debug_buf);
+    frame_dirty_debug = false;
+  }
+  frame_time = rc_now_ms();
+  frame_count++;
+  if(PROFILING) rc_profile_tick()->frames++;
+}
+
+/**
+ * Schedule a flush of the dirty UI state, no sooner than FRAME_INTERVAL_MS after the last one.
+ */
+void rc_request_frame(){
+  if(frame_timer != NULL){
+    frame_coalesced++;
+    return;
+  }
+  uint64_t elapsed = rc_now_ms() - frame_time;
+  uint32_t delay = (elapsed < FRAME_INTERVAL_MS) ? FRAME_INTERVAL_MS - elapsed : 0;
+  frame_timer = app_timer_register(delay, rc_flush_frame, NULL);
+}
 
+// The predictor counts which key follows which and, after each press, jumps the
+// cursor to the key that most often came next.  Counts are halved when one
+// saturates so old habits fade.  The table is persisted in halves since a
+// persisted value is limited to 256 bytes.
+#define PREDICT_KEYS 18 // buttons on the calculator
+#define PREDICT_MIN_COUNT 3 // transitions seen before the cursor will jump
+#define PREDICT_PERSIST_ROWS 9
+#define PERSIST_KEY_PREDICT 2 // and 3
+uint8_t predict_counts[PREDICT_KEYS][PREDICT_KEYS];
+int predict_prev = -1; // id of the last key pressed
+int predict_keystrokes = 0; // presses following another press
+int predict_moves = 0;      // cursor steps taken
+int predict_from_key = 0;   // fewest steps needed from the last key pressed
+int predict_from_start = 0; // fewest steps needed from where the cursor was left
+int predict_start_x = 0;    // cursor position left after the last press
+int predict_start_y = 0;
+
+/**
+ * Step the cursor according to the tilt.  Only the position is updated here,
+ * the inverter layer follows on the next frame.
+ */
 void update_cursor(){
   int x = calc->cursor.x;
   int y = calc->cursor.y;
@@ -276,17 +518,16 @@ void update_cursor(){
     }
   }
   if(update){
-    inverter_layer_destroy(_invlayers[calc->cursor.invid]);
-    _invlayers[calc->cursor.invid] = inverter_layer_create(GRect(x, y, SIZE_BUTTON_X, SIZE_BUTTON_Y));
-    layer_add_child(window_get_root_layer(_windows[calc->winid]), inverter_layer_get_layer(_invlayers[calc->cursor.invid]));
     calc->cursor.x = x;
     calc->cursor.y = y;
+    frame_dirty_cursor = true;
+    if(predict_prev >= 0) predict_moves++; // only steps between presses count
   }
 }
 
 rc_buttonset* rc_create_buttonset(rc_calculator* calc){
   calc->buttonset = malloc(sizeof(rc_buttonset));
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Allocated %d at %p for buttonset", sizeof(rc_buttonset), calc->buttonset); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Allocated %d at %p for buttonset", sizeof(rc_buttonset), calc->buttonset);
   memset(calc->buttonset, 0, sizeof(rc_buttonset));
   calc->buttonset->curx = POSITION_BUTTONS_X;
   calc->buttonset->cury = POSITION_BUTTONS_Y;
@@ -295,10 +536,11 @@ rc_buttonset* rc_create_buttonset(rc_calculator* calc){
 
 void rc_add_button(rc_calculator* calc, char* label, int type, int value){
   calc->buttonset->buttons[calc->buttonset->count] = malloc(sizeof(rc_button));
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Allocated %d at %p for button %s", sizeof(rc_calculator), calc, label); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Allocated %d at %p for button %s", sizeof(rc_calculator), calc, label);
   memset(calc->buttonset->buttons[calc->buttonset->count], 0, sizeof(rc_button));
   calc->buttonset->buttons[calc->buttonset->count]->value = value;
   calc->buttonset->buttons[calc->buttonset->count]->type = type;
+  calc->buttonset->buttons[calc->buttonset->count]->id = calc->buttonset->count;
   calc->buttonset->buttons[calc->buttonset->count]->top = calc->buttonset->cury;
   calc->buttonset->buttons[calc->buttonset->count]->left = calc->buttonset->curx;
   int tlid = getTextlayer(GRect(
@@ -315,7 +557,7 @@ void rc_add_button(rc_calculator* calc, char* label, int type, int value){
   text_layer_set_text(_textlayers[tlid], _buffers[bufid]);
   layer_add_child(window_get_root_layer(_windows[calc->winid]), text_layer_get_layer(_textlayers[tlid]));
   
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Placed button at %d, %d", calc->buttonset->curx, calc->buttonset->cury); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Placed button at %d, %d", calc->buttonset->curx, calc->buttonset->cury);
 
   
   // increment offsets
@@ -373,9 +615,9 @@ void update_vdiff(){
   //vdiff.x = vcurr.x - vbase.x;
   //vdiff.y = vcurr.y - vbase.y;
   //vdiff.z = vcurr.z - vbase.z;
-  vdiff.x = rc_get_smoother_value(&(vfast.sx)) - rc_get_smoother_value(&(vslow.sx));
-  vdiff.y = rc_get_smoother_value(&(vfast.sy)) - rc_get_smoother_value(&(vslow.sy));
-  vdiff.z = rc_get_smoother_value(&(vfast.sz)) - rc_get_smoother_value(&(vslow.sz));
+  vdiff.x = rc_get_smoother_value(&(vfast.sx), SMOOTHER_FAST_BITS) - rc_get_smoother_value(&(vslow.sx), SMOOTHER_SLOW_BITS);
+  vdiff.y = rc_get_smoother_value(&(vfast.sy), SMOOTHER_FAST_BITS) - rc_get_smoother_value(&(vslow.sy), SMOOTHER_SLOW_BITS);
+  vdiff.z = rc_get_smoother_value(&(vfast.sz), SMOOTHER_FAST_BITS) - rc_get_smoother_value(&(vslow.sz), SMOOTHER_SLOW_BITS);
 }
 
 void update_tilt(){
@@ -411,38 +653,90 @@ void update_tilt(){
 Note: if the sampler stops getting called then it's probably time for a watch reboot.
  */
 void rc_handle_sampler(AccelData *data, uint32_t num_samples){ 
-  if(shutdown) return;
-  // get start time
-  time_t ts0;
-  uint16_t tms0;
-  time_ms(&ts0, &tms0);  
-  rc_update_smoothvector3(&vslow, data, num_samples);
-  rc_update_smoothvector3(&vfast, data, num_samples);
+  if(shutdown || num_samples == 0) return;
+  uint64_t t0 = rc_now_ms();
+  sampler_batches++;
+  // a gap between batches longer than a sample period means batches were lost
+  if(sample_time > 0 && data[0].timestamp > sample_time + ACCEL_SAMPLE_PERIOD_MS * 3 / 2){
+    int missing = (data[0].timestamp - sample_time) / ACCEL_SAMPLE_PERIOD_MS - 1;
+    sampler_dropped += (missing + ACCEL_SAMPLES_PER_BATCH / 2) / ACCEL_SAMPLES_PER_BATCH;
+  }
+  sample_time = data[num_samples-1].timestamp;
+  if(sampler_reseed){ // the watch may be held differently than before the suspend
+    rc_seed_smoothvector3(&vslow, &data[0], SMOOTHER_SLOW_BITS);
+    rc_seed_smoothvector3(&vfast, &data[0], SMOOTHER_FAST_BITS);
+    sampler_reseed = false;
+  }
+  rc_update_smoothvector3(&vslow, data, num_samples, SMOOTHER_SLOW_BITS);
+  rc_update_smoothvector3(&vfast, data, num_samples, SMOOTHER_FAST_BITS);
   update_tilt();
   if(data[num_samples-1].timestamp - tilt_time > THRESH_TIME){
     update_cursor();
     tilt_time = data[num_samples-1].timestamp;
   }
-  // get end time and update scan time
-  time_t ts1;
-  uint16_t tms1;
-  time_ms(&ts1, &tms1);  
-  if(ts1 > ts0){
-    tms1 += 1000 * (ts1-ts0);
-  }
-  scan_time = tms1 - tms0;
-  if(num_samples > 0){
-    //int s = 10; // scale factor
-    //snprintf(tl_debug_buf, 256, "x%dy%dz%d  tilt %d %d", data[0].x/s, data[0].y/s, data[0].z/s, tilt, scan_time);
-    snprintf(tl_debug_buf, 256, "x%dy%dz%d  tilt %d ", vdiff.x, vdiff.y, vdiff.z, tilt);
-    strcat(tl_debug_buf, tl_debug_buf2);
-    if(DEBUG) text_layer_set_text(tl_debug, tl_debug_buf);
+  if(frame_dirty_cursor) activity_time = t0;
+  if(DEBUG) frame_dirty_debug = true;
+  rc_profile_bucket* pb = PROFILING ? rc_profile_tick() : NULL; // may mark the overlay dirty
+  if(frame_dirty_cursor || frame_dirty_debug) rc_request_frame();
+  scan_time = rc_now_ms() - t0;
+  if(scan_time > scan_time_max) scan_time_max = scan_time;
+  if(pb != NULL){
+    pb->callbacks++;
+    pb->sampler_ms += scan_time;
+  }
+}
+
+void rc_handle_tap(AccelAxisType axis, int32_t direction){
+  if(app_in_focus) rc_sampler_resume();
+}
+
+void rc_sampler_suspend(){
+  if(!sampler_active) return;
+  accel_data_service_unsubscribe();
+  accel_tap_service_subscribe(rc_handle_tap);
+  if(idle_timer != NULL){
+    app_timer_cancel(idle_timer);
+    idle_timer = NULL;
+  }
+  sampler_active = false;
+  suspend_time = rc_now_ms();
+  suspend_count++;
+}
+
+void rc_handle_idle(void* data){
+  idle_timer = NULL;
+  uint64_t elapsed = rc_now_ms() - activity_time;
+  if(elapsed >= IDLE_TIMEOUT_MS){
+    rc_sampler_suspend();
   } else {
-    snprintf(tl_debug_buf, 256, "not enough samples");
-    text_layer_set_text(tl_debug, tl_debug_buf);
+    idle_timer = app_timer_register(IDLE_TIMEOUT_MS - elapsed, rc_handle_idle, NULL);
   }
 }
 
+void rc_sampler_resume(){
+  if(sampler_active || shutdown) return;
+  if(window_stack_get_top_window() != sampler_window) return; // cursor isn't visible
+  if(suspend_time > 0){
+    accel_tap_service_unsubscribe();
+    suspended_ms += rc_now_ms() - suspend_time;
+    suspend_time = 0;
+    if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "sampler resumed, %d suspensions, %ds suspended", suspend_count, (int)(suspended_ms / 1000));
+  }
+  accel_data_service_subscribe(ACCEL_SAMPLES_PER_BATCH, rc_handle_sampler);
+  accel_service_set_sampling_rate(ACCEL_SAMPLING_50HZ);
+  sampler_active = true;
+  sampler_reseed = true;
+  sample_time = 0; // the gap while suspended isn't dropped batches
+  activity_time = rc_now_ms();
+  idle_timer = app_timer_register(IDLE_TIMEOUT_MS, rc_handle_idle, NULL);
+}
+
+void rc_handle_focus(bool in_focus){
+  app_in_focus = in_focus;
+  if(in_focus) rc_sampler_resume();
+  else rc_sampler_suspend();
+}
+
 void rc_add_cursor(rc_calculator* calc){
   int x = POSITION_BUTTONS_X;
   int y = POSITION_BUTTONS_Y;
@@ -462,6 +756,64 @@ rc_button* rc_get_current_button(){
   return NULL;
 }
 
+/**
+ * Fewest cursor steps between two points; a diagonal tilt moves both axes at once.
+ */
+int rc_cursor_steps(int x0, int y0, int x1, int y1){
+  int dx = abs(x1 - x0) / SIZE_BUTTON_X;
+  int dy = abs(y1 - y0) / SIZE_BUTTON_Y;
+  return (dx > dy) ? dx : dy;
+}
+
+void rc_predict_load(){
+  memset(predict_counts, 0, sizeof(predict_counts));
+  for(int k = 0; k * PREDICT_PERSIST_ROWS < PREDICT_KEYS; k++){
+    if(persist_exists(PERSIST_KEY_PREDICT + k)){
+      persist_read_data(PERSIST_KEY_PREDICT + k, predict_counts[k * PREDICT_PERSIST_ROWS], PREDICT_PERSIST_ROWS * PREDICT_KEYS);
+    }
+  }
+}
+
+void rc_predict_save(){
+  for(int k = 0; k * PREDICT_PERSIST_ROWS < PREDICT_KEYS; k++){
+    persist_write_data(PERSIST_KEY_PREDICT + k, predict_counts[k * PREDICT_PERSIST_ROWS], PREDICT_PERSIST_ROWS * PREDICT_KEYS);
+  }
+}
+
+/**
+ * Record the press of a button, then move the cursor to the likely next key.
+ */
+void rc_predict_press(rc_button* button){
+  if(button->id >= PREDICT_KEYS) return;
+  if(predict_prev >= 0){
+    rc_button* prev = calc->buttonset->buttons[predict_prev];
+    predict_keystrokes++;
+    predict_from_key += rc_cursor_steps(prev->left, prev->top, button->left, button->top);
+    predict_from_start += rc_cursor_steps(predict_start_x, predict_start_y, button->left, button->top);
+    uint8_t* row = predict_counts[predict_prev];
+    if(row[button->id] == 255){
+      for(int i = 0; i < PREDICT_KEYS; i++) row[i] /= 2;
+    }
+    row[button->id]++;
+  }
+  predict_prev = button->id;
+  if(PREDICT){
+    uint8_t* row = predict_counts[button->id];
+    int best = -1;
+    for(int i = 0; i < PREDICT_KEYS; i++){
+      if(row[i] >= PREDICT_MIN_COUNT && (best < 0 || row[i] > row[best])) best = i;
+    }
+    if(best >= 0 && best < calc->buttonset->count){
+      calc->cursor.x = calc->buttonset->buttons[best]->left;
+      calc->cursor.y = calc->buttonset->buttons[best]->top;
+      frame_dirty_cursor = true;
+      rc_request_frame();
+    }
+  }
+  predict_start_x = calc->cursor.x;
+  predict_start_y = calc->cursor.y;
+}
+
 /**
  *  pow() implementation.
  */
@@ -494,7 +846,7 @@ float rc_get_number_value(){
   for(int i = 0; i < end; i++){ // process integer part
     if(num[i] == '-'){
       neg = true;
-    } else {
+    } else if(num[i] >= '0' && num[i] <= '9'){ // skips an "E" display
       // 0 is ascii 48
       float cval = (int)(num[i]) - 48;
       val += cval * rc_pow(10, end - i - 1);
@@ -515,33 +867,197 @@ float rc_get_number_value(){
 #define FRACTION_DIGITS 6 // must be same as number of zeroes in mulitplier
 #define FRACTION_MULTIPLIER 1000000
 
+#define FRACTION_MAX 1000000000 // magnitudes from here on don't fit the int formatting
+
 /**
- *  Format float for the number display using only integer formatting.
+ *  Format float for display using only integer formatting.
+ *  Writes at most size bytes; digits that don't fit are cut from the end.
  */
+void rc_format_number(char* out, int size, float value){
+  float a = rc_abs(value);
+  if(!(a < FRACTION_MAX)){ // also catches a NaN
+    snprintf(out, size, "E");
+    return;
+  }
+  // this method adds a max of six decimal places, then cuts off trailing zeroes.
+  int whole = (int)a;
+  int frac = (int)((a - whole) * FRACTION_MULTIPLIER + 0.5f);
+  if(frac >= FRACTION_MULTIPLIER){ // rounded up into the integer part
+    whole++;
+    frac = 0;
+  }
+  int len = snprintf(out, size, (value < 0 && (whole > 0 || frac > 0)) ? "-%d" : "%d", whole);
+  if(frac > 0 && len < size - 1){
+    char buf[FRACTION_DIGITS + 2];
+    int digits = FRACTION_DIGITS;
+    while(frac % 10 == 0){
+      frac /= 10;
+      digits--;
+    }
+    buf[0] = '.';
+    for(int i = digits; i > 0; i--){ // zero-padded from the right
+      buf[i] = '0' + frac % 10;
+      frac /= 10;
+    }
+    buf[digits + 1] = 0;
+    snprintf(out + len, size - len, "%s", buf);
+  }
+}
+
 void rc_update_number_buffer(float value){
-  snprintf(_buffers[calc->bufid_num], 256, "%d", (int)value);
-  if((int)value != value){ // need to add decimal part
-    // this method adds a max of six decimal places, then cuts off trailing zeroes.
-    char buf[256];
-    char zbuf[32];
-    memset(zbuf, '0', 32);
-    float frac = value - (int)value;
-    frac *= FRACTION_MULTIPLIER; // this multiplier determines max number of decimals
-    snprintf(buf, 256, "%d", (int)frac);
-    int zlen = FRACTION_DIGITS - strlen(buf); // zlen is the length before zero-padding
-    for(int i = strlen(buf) - 1; i > -1; i--){
-      if(buf[i] == '0'){
-        buf[i] = 0;
-      }
+  rc_format_number(_buffers[calc->bufid_num], GLOBAL_BUFFER_SIZE, value);
+}
+
+/**
+ * Apply an operator; division by zero gives 0.
+ */
+float rc_calculate(int op, float val0, float val1){
+  switch(op){
+    case BUTTON_FUNCTION_ADD:
+      return val0 + val1;
+    case BUTTON_FUNCTION_SUB:
+      return val0 - val1;
+    case BUTTON_FUNCTION_MUL:
+      return val0 * val1;
+    case BUTTON_FUNCTION_DIV:
+      if(val1 == 0) return 0; // TODO: display error
+      return val0 / val1;
+  }
+  return 0;
+}
+
+void rc_history_push(float value){
+  history.values[history.head] = value;
+  history.head = (history.head + 1) % HISTORY_CAPACITY;
+  if(history.count < HISTORY_CAPACITY) history.count++;
+}
+
+/**
+ * Return the i-th most recent result, 0 being the newest.
+ */
+float rc_history_get(int i){
+  return history.values[(history.head - 1 - i + HISTORY_CAPACITY) % HISTORY_CAPACITY];
+}
+
+void rc_history_load(){
+  memset(&history, 0, sizeof(rc_history));
+  if(persist_exists(PERSIST_KEY_HISTORY)){
+    persist_read_data(PERSIST_KEY_HISTORY, &history, sizeof(rc_history));
+    if(history.head < 0 || history.head >= HISTORY_CAPACITY || history.count < 0 || history.count > HISTORY_CAPACITY){
+      if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Discarding corrupt history.");
+      memset(&history, 0, sizeof(rc_history));
     }
-    memcpy(zbuf + zlen, buf, strlen(buf) + 1);
-    strcpy(buf, zbuf);
-    strcat(_buffers[calc->bufid_num], ".");
-    strcat(_buffers[calc->bufid_num], buf);
   }
 }
 
+void rc_history_save(){
+  persist_write_data(PERSIST_KEY_HISTORY, &history, sizeof(rc_history));
+}
+
+/**
+ * Bind the visible rows to the entries starting at history_top and move the highlight.
+ */
+void rc_history_render(){
+  for(int r = 0; r < HISTORY_ROWS; r++){
+    int i = calc->history_top + r;
+    if(i < history.count){
+      rc_format_number(_buffers[calc->bufid_history[r]], GLOBAL_BUFFER_SIZE, rc_history_get(i));
+    } else {
+      strcpy(_buffers[calc->bufid_history[r]], "");
+    }
+    text_layer_set_text(_textlayers[calc->tlid_history[r]], _buffers[calc->bufid_history[r]]);
+  }
+  if(history.count == 0){
+    strcpy(_buffers[calc->bufid_history[0]], "no history");
+    text_layer_set_text(_textlayers[calc->tlid_history[0]], _buffers[calc->bufid_history[0]]);
+  }
+  Layer* highlight = inverter_layer_get_layer(_invlayers[calc->invid_history]);
+  layer_set_hidden(highlight, history.count == 0);
+  layer_set_frame(highlight, GRect(0, HISTORY_ROW_HEIGHT * (calc->history_sel - calc->history_top), SCREEN_WIDTH, HISTORY_ROW_HEIGHT));
+}
+
+void rc_history_scroll(int delta){
+  int sel = calc->history_sel + delta;
+  if(sel < 0 || sel >= history.count) return;
+  calc->history_sel = sel;
+  if(sel < calc->history_top) calc->history_top = sel;
+  if(sel >= calc->history_top + HISTORY_ROWS) calc->history_top = sel - HISTORY_ROWS + 1;
+  rc_history_render();
+}
+
+/**
+ * Put a stored result in the number display, ready to be used as an operand.
+ */
+void rc_history_recall(int i){
+  if(i >= history.count) return;
+  if(calc->mode == CALC_MODE_NEWOP){ // recalling starts a new operation, like a digit would
+    calc->tmpval = 0;
+    calc->tmpop = 0;
+    strcpy(_buffers[calc->bufid_op], CALC_OP_INITIAL);
+  }
+  rc_update_number_buffer(rc_history_get(i));
+  calc->mode = CALC_MODE_MIDOP; // a digit replaces the recalled number, an operator uses it
+  text_layer_set_text(_textlayers[calc->tlid_num], _buffers[calc->bufid_num]);
+  text_layer_set_text(_textlayers[calc->tlid_op], _buffers[calc->bufid_op]);
+}
+
+void history_up_click_handler(ClickRecognizerRef recognizer, void *context) {
+  uint64_t t0 = PROFILING ? rc_now_ms() : 0;
+  rc_history_scroll(-1);
+  rc_profile_click(t0);
+}
+
+void history_down_click_handler(ClickRecognizerRef recognizer, void *context) {
+  uint64_t t0 = PROFILING ? rc_now_ms() : 0;
+  rc_history_scroll(1);
+  rc_profile_click(t0);
+}
+
+void history_select_click_handler(ClickRecognizerRef recognizer, void *context) {
+  uint64_t t0 = PROFILING ? rc_now_ms() : 0;
+  rc_history_recall(calc->history_sel);
+  window_stack_pop(true);
+  rc_profile_click(t0);
+}
+
+void history_config_provider(void *context) {
+  window_single_click_subscribe(BUTTON_ID_UP, history_up_click_handler);
+  window_single_click_subscribe(BUTTON_ID_DOWN, history_down_click_handler);
+  window_single_click_subscribe(BUTTON_ID_SELECT, history_select_click_handler);
+}
+
+void rc_add_history(rc_calculator* calc){
+  calc->winid_history = getWindow();
+  Layer* root = window_get_root_layer(_windows[calc->winid_history]);
+  for(int r = 0; r < HISTORY_ROWS; r++){
+    int tlid = getTextlayer(GRect(POSITION_BUTTONS_X, HISTORY_ROW_HEIGHT * r, SCREEN_WIDTH - 2 * POSITION_BUTTONS_X, HISTORY_ROW_HEIGHT));
+    int bufid = getBuffer();
+    text_layer_set_text(_textlayers[tlid], _buffers[bufid]);
+    text_layer_set_text_alignment(_textlayers[tlid], GTextAlignmentRight);
+    text_layer_set_font(_textlayers[tlid], fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
+    layer_add_child(root, text_layer_get_layer(_textlayers[tlid]));
+    calc->tlid_history[r] = tlid;
+    calc->bufid_history[r] = bufid;
+  }
+  calc->invid_history = getInvlayer(GRect(0, 0, SCREEN_WIDTH, HISTORY_ROW_HEIGHT));
+  layer_add_child(root, inverter_layer_get_layer(_invlayers[calc->invid_history]));
+  window_set_click_config_provider(_windows[calc->winid_history], history_config_provider);
+}
+
+/**
+ * Show the history window with the newest result selected.
+ */
+void rc_open_history(){
+  calc->history_sel = 0;
+  calc->history_top = 0;
+  rc_history_render();
+  window_stack_push(_windows[calc->winid_history], true);
+}
+
 void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+  if(!sampler_active) rc_sampler_resume(); // the cursor stayed put while suspended, so the key under it is meant
+  uint64_t t0 = rc_now_ms();
+  activity_time = t0;
   rc_button* button = rc_get_current_button();
   if(button != NULL){    
     if(button->type == BUTTON_TYPE_NUMBER){
@@ -555,10 +1071,11 @@ void select_click_handler(ClickRecognizerRef recognizer, void *context) {
         strcpy(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
         calc->mode = CALC_MODE_INPUT;
       }
-      if(rc_get_number_value() == 0 && _buffers[calc->bufid_num][strlen(_buffers[calc->bufid_num])-1] != '.'){ // replace
-        strcpy(_buffers[calc->bufid_num], _buffers[button->bufid]);
-      } else { // append
-        strcat(_buffers[calc->bufid_num], _buffers[button->bufid]);
+      char digit[2] = {'0' + button->value, 0}; // same as the label, but can't alias the display buffer
+      if(rc_get_number_value() == 0 && strchr(_buffers[calc->bufid_num], '.') == NULL){ // replace
+        strcpy(_buffers[calc->bufid_num], digit);
+      } else if(strlen(_buffers[calc->bufid_num]) + 1 < GLOBAL_BUFFER_SIZE){ // append
+        strcat(_buffers[calc->bufid_num], digit);
       }      
       snprintf(tl_debug_buf2, 256, " %d", (int)rc_get_number_value());//debug
     } else if(button->type == BUTTON_TYPE_FUNCTION){
@@ -574,42 +1091,36 @@ void select_click_handler(ClickRecognizerRef recognizer, void *context) {
       switch(button->value){
         case BUTTON_FUNCTION_EQU:
           if(calc->tmpop > 0){
-            switch(calc->tmpop){
-              case BUTTON_FUNCTION_ADD:
-                res = val0 + val1;
-                break;
-              case BUTTON_FUNCTION_SUB:
-                res = val0 - val1;
-                break;
-              case BUTTON_FUNCTION_MUL:
-                res = val0 * val1;
-                break;
-              case BUTTON_FUNCTION_DIV:
-                if(val1 == 0){
-                  res = 0; // TODO: display error
-                  //strcpy(_buffers[calc->bufid_num], "E");
-                } else {
-                  res = val0 / val1;  
-                }                
-                break;
-            }
+            res = rc_calculate(calc->tmpop, val0, val1);
             //strcpy(_buffers[calc->bufid_op], "");
             calc->tmpval = val1; // so we can chain operations
             rc_update_number_buffer(res);
+            rc_history_push(res);
             calc->mode = CALC_MODE_NEWOP;
           }
           break;
-        case BUTTON_FUNCTION_MUL:          
-          strcpy(_buffers[calc->bufid_op], _buffers[button->bufid]);
-          calc->tmpval = rc_get_number_value();
-          calc->tmpop = BUTTON_FUNCTION_MUL;
-          //strcpy(_buffers[calc->bufid_num], CALC_VALUE_INITIAL);
+        case BUTTON_FUNCTION_ADD:
+        case BUTTON_FUNCTION_SUB:
+        case BUTTON_FUNCTION_MUL:
+        case BUTTON_FUNCTION_DIV:
+          if(calc->mode == CALC_MODE_INPUT && calc->tmpop > 0){ // finish the pending operation, so 5+5+5 chains
+            res = rc_calculate(calc->tmpop, calc->tmpval, rc_get_number_value());
+            rc_update_number_buffer(res);
+            calc->tmpval = res;
+          } else if(calc->mode != CALC_MODE_MIDOP){ // straight after another operator, only the operator changes
+            calc->tmpval = rc_get_number_value();
+          }
+          _buffers[calc->bufid_op][0] = _buffers[button->bufid][0]; // operator labels are one character
+          _buffers[calc->bufid_op][1] = 0;
+          calc->tmpop = button->value;
           calc->mode = CALC_MODE_MIDOP;
           break;
         case BUTTON_FUNCTION_CLE:
           strcpy(_buffers[calc->bufid_op], CALC_OP_INITIAL);
           strcpy(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
           calc->tmpval = 0;
+          calc->tmpop = 0; // nothing left pending once the operator display is gone
+          calc->mode = CALC_MODE_NEWOP;
           break;
         case BUTTON_FUNCTION_BAC:
           //if(rc_get_number_value() != 0){
@@ -618,15 +1129,11 @@ void select_click_handler(ClickRecognizerRef recognizer, void *context) {
             } else {
               strcpy(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
             }
+            if(strcmp(_buffers[calc->bufid_num], "-") == 0){ // nothing left of a negative result
+              strcpy(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
+            }
           //}
           break;
-        case BUTTON_FUNCTION_DIV:
-          strcpy(_buffers[calc->bufid_op], _buffers[button->bufid]);
-          calc->tmpval = rc_get_number_value();
-          calc->tmpop = BUTTON_FUNCTION_DIV;
-          //strcpy(_buffers[calc->bufid_num], "0");
-          calc->mode = CALC_MODE_MIDOP;
-          break;
         case BUTTON_FUNCTION_DOT: ; // empty statement to allow next line to be a declaraion
           if(calc->mode == CALC_MODE_NEWOP){
             calc->tmpval = 0;
@@ -644,37 +1151,25 @@ void select_click_handler(ClickRecognizerRef recognizer, void *context) {
           for(int i = 0; i < dlen; i++){
             if(dnum[i] == '.') dhas = true;
           }
-          if(!dhas){
+          if(!dhas && dlen + 1 < GLOBAL_BUFFER_SIZE){
             strcat(_buffers[calc->bufid_num], ".");            
             calc->mode = CALC_MODE_INPUT;
           }
           break; 
-        case BUTTON_FUNCTION_ADD:
-          strcpy(_buffers[calc->bufid_op], _buffers[button->bufid]);
-          calc->tmpval = rc_get_number_value();
-          calc->tmpop = BUTTON_FUNCTION_ADD;
-          //strcpy(_buffers[calc->bufid_num], "0");
-          calc->mode = CALC_MODE_MIDOP;
-          break;
-        case BUTTON_FUNCTION_SUB:
-          strcpy(_buffers[calc->bufid_op], _buffers[button->bufid]);
-          calc->tmpval = rc_get_number_value();
-          calc->tmpop = BUTTON_FUNCTION_SUB;
-          //strcpy(_buffers[calc->bufid_num], "0");
-          calc->mode = CALC_MODE_MIDOP;
-          break;
         default:
-          APP_LOG(APP_LOG_LEVEL_ERROR, "Button has an invalid value.");
+          if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Button has an invalid value.");
           break;
       }
     } else {
-      APP_LOG(APP_LOG_LEVEL_ERROR, "Button has an invalid type.");
+      if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Button has an invalid type.");
     }
     text_layer_set_text(_textlayers[calc->tlid_num], _buffers[calc->bufid_num]);
     text_layer_set_text(_textlayers[calc->tlid_op], _buffers[calc->bufid_op]);
+    rc_predict_press(button);
   } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Unable to resolve button from cursor.");
+    if(LOGGING) APP_LOG(APP_LOG_LEVEL_ERROR, "Unable to resolve button from cursor.");
   }
+  rc_profile_click(t0);
 }
 
 void layer_update_proc(struct Layer *layer, GContext *ctx){
@@ -687,20 +1182,53 @@ void layer_update_proc(struct Layer *layer, GContext *ctx){
   graphics_draw_line(ctx, GPoint(POSITION_BUTTONS_X, POSITION_BUTTONS_Y - 3), GPoint(139, POSITION_BUTTONS_Y - 3));
 }
 
+void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+  uint64_t t0 = PROFILING ? rc_now_ms() : 0;
+  rc_open_history();
+  rc_profile_click(t0);
+}
+
+void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+  uint64_t t0 = PROFILING ? rc_now_ms() : 0;
+  rc_history_recall(0);
+  rc_profile_click(t0);
+}
+
 void config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+  window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+  window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+}
+
+// the sampler only runs while the calculator window is on top
+void window_appear(Window* window){
+  rc_sampler_resume();
+}
+
+void window_disappear(Window* window){
+  rc_sampler_suspend();
 }
 
 rc_calculator* rc_create_calculator(rc_calculator* calc){
   init_global_resources();
   calc = malloc(sizeof(rc_calculator));
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Allocated %d at %p for calculator", sizeof(rc_calculator), calc); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Allocated %d at %p for calculator", sizeof(rc_calculator), calc);
   memset(calc, 0, sizeof(rc_calculator));
   calc->buttonset = rc_create_buttonset(calc);
   calc->winid = getWindow();
   rc_add_buttons(calc);
   rc_add_cursor(calc);
   layer_set_update_proc(window_get_root_layer(_windows[calc->winid]), layer_update_proc);
+
+  // setup smoothers before the window appears and starts the sampler
+  rc_setup_smoothvector3(&vfast, vfast_buf, SMOOTHER_FAST_BITS);
+  rc_setup_smoothvector3(&vslow, vslow_buf, SMOOTHER_SLOW_BITS);
+  accel_data_service_unsubscribe(); // reset?
+  sampler_window = _windows[calc->winid];
+  window_set_window_handlers(_windows[calc->winid], (WindowHandlers){
+    .appear = window_appear,
+    .disappear = window_disappear,
+  });
   window_stack_push(_windows[calc->winid], true);
   
   // set up operator indicator and number window
@@ -718,41 +1246,71 @@ rc_calculator* rc_create_calculator(rc_calculator* calc){
   layer_add_child(window_get_root_layer(_windows[calc->winid]), text_layer_get_layer(_textlayers[calc->tlid_num]));
   strcat(_buffers[calc->bufid_num], CALC_NUM_INITIAL);
   
-  // subscribe to accelerometer data updates
-  accel_data_service_unsubscribe(); // reset?
-  accel_data_service_subscribe(4, rc_handle_sampler);
-  accel_service_set_sampling_rate(ACCEL_SAMPLING_50HZ);
+  // subscribe to accelerometer data updates, and pause them while out of focus
+  rc_sampler_resume(); // no-op if the window's appear handler already started it
   //accel_service_set_samples_per_update(5);
-  
-  // setup smoothers
-  rc_setup_smoothvector3(&vfast, 4);
-  rc_setup_smoothvector3(&vslow, 64);
+  app_focus_service_subscribe(rc_handle_focus);
 
   // setup click handlers
   window_set_click_config_provider(_windows[calc->winid], config_provider);
+
+  // setup history tape
+  rc_history_load();
+  rc_add_history(calc);
+  rc_predict_load();
   return calc;
 }
 
 void rc_destroy_calculator(rc_calculator* calc){
   shutdown = true;
-  // unsubscribe from data service
-  accel_data_service_unsubscribe();
+  rc_history_save();
+  rc_predict_save();
+  // unsubscribe from data services
+  app_focus_service_unsubscribe();
+  if(sampler_active){
+    accel_data_service_unsubscribe();
+  } else if(suspend_time > 0){ // the sampler may never have started
+    accel_tap_service_unsubscribe();
+    suspended_ms += rc_now_ms() - suspend_time;
+  }
+  if(idle_timer != NULL){
+    app_timer_cancel(idle_timer);
+    idle_timer = NULL;
+  }
+  if(frame_timer != NULL){
+    app_timer_cancel(frame_timer);
+    frame_timer = NULL;
+  }
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "sampler: %d batches, %d dropped, %dms max; %d frames, %d coalesced",
+    sampler_batches, sampler_dropped, scan_time_max, frame_count, frame_coalesced);
+  if(LOGGING || PROFILING) APP_LOG(APP_LOG_LEVEL_INFO, "sampler suspended %d times for %ds, %d batches avoided",
+    suspend_count, (int)(suspended_ms / 1000), (int)(suspended_ms / (ACCEL_SAMPLES_PER_BATCH * ACCEL_SAMPLE_PERIOD_MS)));
+  if((LOGGING || PROFILING) && predict_keystrokes > 0) APP_LOG(APP_LOG_LEVEL_INFO,
+    "predictor %s: %d keys, steps per key %d/100 taken, %d/100 needed from last key, %d/100 needed from predicted key",
+    PREDICT ? "on" : "off", predict_keystrokes, 100 * predict_moves / predict_keystrokes,
+    100 * predict_from_key / predict_keystrokes, 100 * predict_from_start / predict_keystrokes);
+  if(PROFILING){
+    rc_profile_bucket r;
+    rc_profile_rates(&r);
+    APP_LOG(APP_LOG_LEVEL_INFO, "profile over %ds, per second: %d callbacks, %dms sampler, %d clicks, %dms click, %d frames; heap max %d",
+      profiler.n, r.callbacks, r.sampler_ms, r.clicks, r.click_ms, r.frames, profiler.heap_max);
+  }
   // destroy global resources
   for(int i = 0; i < _textlayersn; i++){
     if(_textlayers[i] != NULL){
-      if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "rc_destory_calculator: destroy textlayer %d", i); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+      if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "rc_destory_calculator: destroy textlayer %d", i);
       text_layer_destroy(_textlayers[i]);
     }
   }
   for(int i = 0; i < _invlayersn; i++){
     if(_invlayers[i] != NULL){
-      if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "rc_destory_calculator: destroy invlayer %d", i); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+      if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "rc_destory_calculator: destroy invlayer %d", i);
       inverter_layer_destroy(_invlayers[i]);
     }
   }    
   for(int i = 0; i < _windowsn; i++){
     if(_windows[i] != NULL){
-      if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "rc_destory_calculator: destroy window %d", i); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+      if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "rc_destory_calculator: destroy window %d", i);
       window_destroy(_windows[i]);
     }
   }
@@ -784,11 +1342,11 @@ int main(void) {
   tl_debug = text_layer_create(GRect(0, 132, 144, 22));
   memset(tl_debug_buf, 0, 256);
   strcat(tl_debug_buf, "hello debug!");
-  if(DEBUG) text_layer_set_text(tl_debug, tl_debug_buf);
+  if(DEBUG || PROFILING) text_layer_set_text(tl_debug, tl_debug_buf);
   
   // initialize the calculator
   calc = rc_create_calculator(calc);
-  if(LOGGING) snprintf(buf_debug, BUF_SIZE_DEBUG, "Allocated %d at %p for calculator", sizeof(rc_calculator), calc); APP_LOG(APP_LOG_LEVEL_INFO, buf_debug);
+  if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "Allocated %d at %p for calculator", sizeof(rc_calculator), calc);
  
   layer_add_child(window_get_root_layer(_windows[0]), text_layer_get_layer(tl_debug));
   //tltest = text_layer_create(GRect(10,10,36,36)); text_layer_set_text(tltest, "!");//works
@@ -799,4 +1357,5 @@ int main(void) {
   if(LOGGING) APP_LOG(APP_LOG_LEVEL_INFO, "starting event loop");
   app_event_loop();
   rc_destroy_calculator(calc);
+  return 0;
 }